@@ -0,0 +1,736 @@
+#include "ResourceLoading.h"
+#include "SoftwareRasterizer.h"
+#include "Uniforms.h"
+#include "VertexAttributes.h"
+
+#include "glm/ext.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Headless benchmarks of the CPU side of App: geometry parsing, vertex
+// deduplication, staging of the vertex upload, the per-frame uniform update,
+// and full frames of SoftwareRasterizer. Needs no window nor GPU.
+//
+//   Bench [--sizes 10000,100000,...] [--max-triangles n] [--asset-dir dir]
+//         [--raster-sizes 1000000,...] [--raster-width w] [--raster-height h]
+//         [--threads n]
+//         [--min-time seconds] [--output results.json]
+//         [--baseline baseline.json] [--threshold 0.1] [--noise-floor ns]
+//
+// Each benchmark keeps sampling until it has both MinIterations samples and
+// --min-time seconds of them. With --baseline, exits with 1 when a gated
+// benchmark has no baseline entry, or when its median is slower than the
+// baseline median by more than the allowed slowdown. That allowance is the
+// threshold (a fraction, 0.1 = 10%) widened by the spread measured in both
+// runs, and the slowdown must also exceed the noise floor (in ns per
+// operation).
+
+namespace fs = std::filesystem;
+
+struct Options
+{
+    std::vector<uint64_t> sizes = { 10000, 100000, 1000000, 10000000 };
+    uint64_t maxTriangles = 0;
+    std::vector<uint64_t> rasterSizes = { 1000000 };
+    uint32_t rasterWidth = 1920, rasterHeight = 1080;
+    // Rasterizer threads, 0 for all hardware threads
+    uint32_t threadCount = 0;
+    fs::path assetDir = "bench_assets";
+    double minTime = 0.5;
+    std::string outputPath;
+    std::string baselinePath;
+    double threshold = 0.1;
+    double noiseFloorNs = 50.0;
+};
+
+struct BenchResult
+{
+    std::string name;
+    uint64_t triangles = 0;
+    int iterations = 0;
+    double medianNs = 0.0;
+    double minNs = 0.0;
+    double meanNs = 0.0;
+    // Interquartile range relative to the median, how noisy the samples were
+    double spread = 0.0;
+    // Whether the baseline comparison can fail on this benchmark. Off for
+    // the ones that only time a copy written here rather than repo code.
+    bool gated = true;
+};
+
+// Sink for benchmark outputs, so that the work is not optimized away
+volatile uint64_t benchSink = 0;
+
+std::vector<uint64_t> parseSizes(char const * value)
+{
+    std::vector<uint64_t> sizes;
+    std::istringstream iss(value);
+    std::string size;
+    while (std::getline(iss, size, ','))
+    {
+        sizes.push_back(std::strtoull(size.c_str(), nullptr, 10));
+    }
+    return sizes;
+}
+
+bool parseOptions(int argc, char ** argv, Options & options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        char const * arg = argv[i];
+        char const * value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (value == nullptr)
+        {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        }
+        ++i;
+
+        if (std::strcmp(arg, "--sizes") == 0) options.sizes = parseSizes(value);
+        else if (std::strcmp(arg, "--raster-sizes") == 0) options.rasterSizes = parseSizes(value);
+        else if (std::strcmp(arg, "--raster-width") == 0) options.rasterWidth = uint32_t(std::atoi(value));
+        else if (std::strcmp(arg, "--raster-height") == 0) options.rasterHeight = uint32_t(std::atoi(value));
+        else if (std::strcmp(arg, "--threads") == 0) options.threadCount = uint32_t(std::atoi(value));
+        else if (std::strcmp(arg, "--max-triangles") == 0) options.maxTriangles = std::strtoull(value, nullptr, 10);
+        else if (std::strcmp(arg, "--asset-dir") == 0) options.assetDir = value;
+        else if (std::strcmp(arg, "--min-time") == 0) options.minTime = std::atof(value);
+        else if (std::strcmp(arg, "--output") == 0) options.outputPath = value;
+        else if (std::strcmp(arg, "--baseline") == 0) options.baselinePath = value;
+        else if (std::strcmp(arg, "--threshold") == 0) options.threshold = std::atof(value);
+        else if (std::strcmp(arg, "--noise-floor") == 0) options.noiseFloorNs = std::atof(value);
+        else
+        {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if (options.maxTriangles > 0)
+    {
+        std::erase_if(options.sizes, [&](uint64_t size) { return size > options.maxTriangles; });
+        std::erase_if(options.rasterSizes, [&](uint64_t size) { return size > options.maxTriangles; });
+    }
+    std::erase(options.sizes, 0);
+    std::erase(options.rasterSizes, 0);
+
+    if (options.rasterWidth == 0 || options.rasterHeight == 0)
+    {
+        std::cerr << "Invalid raster size" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Synthetic assets
+
+// A wavy height field, cut into a grid of cells of two triangles each, and
+// truncated to exactly triangleCount triangles. Vertices are shared between
+// neighbouring cells, so the expanded OBJ data has plenty to deduplicate.
+struct GridMesh
+{
+    uint64_t columns = 0, rows = 0;
+    uint64_t triangleCount = 0;
+
+    explicit GridMesh(uint64_t triangleCount)
+        : triangleCount(triangleCount)
+    {
+        columns = std::max<uint64_t>(1, uint64_t(std::ceil(std::sqrt(double(triangleCount) / 2.0))));
+        rows = (triangleCount + 2 * columns - 1) / (2 * columns);
+    }
+
+    uint64_t VertexCount() const { return (columns + 1) * (rows + 1); }
+
+    void Vertex(uint64_t index, float * position, float * normal, float * color) const
+    {
+        float u = float(index % (columns + 1)) / float(columns);
+        float v = float(index / (columns + 1)) / float(rows);
+        float height = 0.05f * std::sin(12.0f * u) * std::cos(9.0f * v);
+        position[0] = u - 0.5f;
+        position[1] = v - 0.5f;
+        position[2] = height;
+
+        float dx = 0.6f * std::cos(12.0f * u) * std::cos(9.0f * v);
+        float dy = -0.45f * std::sin(12.0f * u) * std::sin(9.0f * v);
+        float invLength = 1.0f / std::sqrt(dx * dx + dy * dy + 1.0f);
+        normal[0] = -dx * invLength;
+        normal[1] = -dy * invLength;
+        normal[2] = invLength;
+
+        color[0] = 0.5f + 0.5f * u;
+        color[1] = 0.5f + 0.5f * v;
+        color[2] = 0.8f;
+    }
+
+    // Corners of triangle t, as vertex indices
+    void Triangle(uint64_t t, uint64_t * corners) const
+    {
+        uint64_t cell = t / 2;
+        uint64_t i = cell % columns, j = cell / columns;
+        uint64_t v00 = j * (columns + 1) + i;
+        uint64_t v10 = v00 + 1;
+        uint64_t v01 = v00 + columns + 1;
+        uint64_t v11 = v01 + 1;
+        if (t % 2 == 0)
+        {
+            corners[0] = v00; corners[1] = v10; corners[2] = v11;
+        }
+        else
+        {
+            corners[0] = v00; corners[1] = v11; corners[2] = v01;
+        }
+    }
+};
+
+// Buffered writer, formatting through std::ofstream is too slow for the
+// largest assets.
+class AssetWriter
+{
+public:
+    explicit AssetWriter(fs::path const & path) : file(path, std::ios::binary) {}
+
+    bool IsOpen() const { return file.is_open(); }
+
+    template <typename... Args>
+    void Print(char const * format, Args... args)
+    {
+        if (buffer.size() - used < 256)
+        {
+            Flush();
+        }
+        used += size_t(std::snprintf(buffer.data() + used, buffer.size() - used, format, args...));
+    }
+
+    bool Flush()
+    {
+        file.write(buffer.data(), used);
+        used = 0;
+        return bool(file);
+    }
+
+private:
+    std::ofstream file;
+    std::vector<char> buffer = std::vector<char>(1 << 20);
+    size_t used = 0;
+};
+
+// Assets are kept across runs, the largest ones take a while to generate.
+bool generateObjAsset(fs::path const & path, GridMesh const & mesh)
+{
+    if (fs::is_regular_file(path))
+    {
+        return true;
+    }
+
+    fs::path partialPath = path.string() + ".partial";
+    {
+        AssetWriter writer(partialPath);
+        if (!writer.IsOpen())
+        {
+            return false;
+        }
+
+        writer.Print("# Synthetic benchmark asset, %llu triangles\no Grid\n", (unsigned long long)mesh.triangleCount);
+        float position[3], normal[3], color[3];
+        for (uint64_t i = 0; i < mesh.VertexCount(); ++i)
+        {
+            mesh.Vertex(i, position, normal, color);
+            writer.Print("v %.6f %.6f %.6f %.4f %.4f %.4f\n", position[0], position[1], position[2], color[0], color[1], color[2]);
+        }
+        for (uint64_t i = 0; i < mesh.VertexCount(); ++i)
+        {
+            mesh.Vertex(i, position, normal, color);
+            writer.Print("vn %.6f %.6f %.6f\n", normal[0], normal[1], normal[2]);
+        }
+        uint64_t corners[3];
+        for (uint64_t t = 0; t < mesh.triangleCount; ++t)
+        {
+            mesh.Triangle(t, corners);
+            // OBJ indices are 1-based
+            writer.Print("f %llu//%llu %llu//%llu %llu//%llu\n",
+                (unsigned long long)corners[0] + 1, (unsigned long long)corners[0] + 1,
+                (unsigned long long)corners[1] + 1, (unsigned long long)corners[1] + 1,
+                (unsigned long long)corners[2] + 1, (unsigned long long)corners[2] + 1);
+        }
+        if (!writer.Flush())
+        {
+            return false;
+        }
+    }
+    std::error_code error;
+    fs::rename(partialPath, path, error);
+    return !error;
+}
+
+// Same layout as resources/pyramid.txt. loadGeometry() reads 16-bit indices,
+// so points come from a mesh small enough to index, and its triangles are
+// repeated to reach the requested count.
+bool generateTxtAsset(fs::path const & path, uint64_t triangleCount)
+{
+    if (fs::is_regular_file(path))
+    {
+        return true;
+    }
+
+    GridMesh mesh(std::min<uint64_t>(triangleCount, 2 * 254 * 254));
+
+    fs::path partialPath = path.string() + ".partial";
+    {
+        AssetWriter writer(partialPath);
+        if (!writer.IsOpen())
+        {
+            return false;
+        }
+
+        writer.Print("# Synthetic benchmark asset, %llu triangles\n[points]\n", (unsigned long long)triangleCount);
+        float position[3], normal[3], color[3];
+        for (uint64_t i = 0; i < mesh.VertexCount(); ++i)
+        {
+            mesh.Vertex(i, position, normal, color);
+            writer.Print("%.6f %.6f %.6f %.6f %.6f %.6f %.4f %.4f %.4f\n",
+                position[0], position[1], position[2], normal[0], normal[1], normal[2], color[0], color[1], color[2]);
+        }
+        writer.Print("[indices]\n");
+        uint64_t corners[3];
+        for (uint64_t t = 0; t < triangleCount; ++t)
+        {
+            mesh.Triangle(t % mesh.triangleCount, corners);
+            writer.Print("%llu %llu %llu\n", (unsigned long long)corners[0], (unsigned long long)corners[1], (unsigned long long)corners[2]);
+        }
+        if (!writer.Flush())
+        {
+            return false;
+        }
+    }
+    std::error_code error;
+    fs::rename(partialPath, path, error);
+    return !error;
+}
+
+// Running and reporting
+
+// Calls body() until both enough time and enough samples were collected.
+// body() returns how many operations it ran, results are per operation.
+BenchResult runBenchmark(std::string const & name, uint64_t triangles, Options const & options, std::function<uint64_t()> const & body)
+{
+    using Clock = std::chrono::steady_clock;
+    constexpr size_t MinIterations = 10;
+    constexpr size_t MaxIterations = 1000;
+
+    // Warm up caches and allocations outside of the samples
+    body();
+
+    std::vector<double> samples;
+    auto start = Clock::now();
+    while (samples.size() < MaxIterations
+        && (samples.size() < MinIterations || std::chrono::duration<double>(Clock::now() - start).count() < options.minTime))
+    {
+        auto sampleStart = Clock::now();
+        uint64_t operations = body();
+        std::chrono::duration<double, std::nano> elapsed = Clock::now() - sampleStart;
+        samples.push_back(elapsed.count() / double(std::max<uint64_t>(operations, 1)));
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    BenchResult result;
+    result.name = name;
+    result.triangles = triangles;
+    result.iterations = int(samples.size());
+    result.medianNs = samples[samples.size() / 2];
+    result.minNs = samples.front();
+    for (double sample : samples)
+    {
+        result.meanNs += sample;
+    }
+    result.meanNs /= double(samples.size());
+    double firstQuartile = samples[samples.size() / 4];
+    double thirdQuartile = samples[samples.size() * 3 / 4];
+    result.spread = result.medianNs > 0.0 ? (thirdQuartile - firstQuartile) / result.medianNs : 0.0;
+
+    std::printf("%-24s %10llu tris  %5d iters  median %14.1f ns  min %14.1f ns  spread %5.1f%%\n",
+        name.c_str(), (unsigned long long)triangles, result.iterations, result.medianNs, result.minNs, result.spread * 100.0);
+    std::fflush(stdout);
+    return result;
+}
+
+std::string resultKey(std::string const & name, uint64_t triangles)
+{
+    return name + "/" + std::to_string(triangles);
+}
+
+bool writeResults(std::string const & path, std::vector<BenchResult> const & results)
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    file << "{\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        BenchResult const & r = results[i];
+        char line[512];
+        std::snprintf(line, sizeof(line),
+            "    {\"name\": \"%s\", \"triangles\": %llu, \"iterations\": %d, \"median_ns\": %.3f, \"min_ns\": %.3f, \"mean_ns\": %.3f, \"spread\": %.4f, \"gated\": %s}%s\n",
+            r.name.c_str(), (unsigned long long)r.triangles, r.iterations, r.medianNs, r.minNs, r.meanNs, r.spread,
+            r.gated ? "true" : "false",
+            i + 1 < results.size() ? "," : "");
+        file << line;
+    }
+    file << "  ]\n}\n";
+    return bool(file);
+}
+
+// Reads back the median times and spreads of a file written by
+// writeResults(). This is not a general JSON parser: it expects one flat
+// object per benchmark.
+bool readBaseline(std::string const & path, std::map<std::string, BenchResult> & baseline)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+    std::string json = contents.str();
+
+    auto field = [](std::string const & object, std::string const & key) -> std::string
+    {
+        size_t pos = object.find("\"" + key + "\"");
+        if (pos == std::string::npos) return {};
+        pos = object.find(':', pos);
+        if (pos == std::string::npos) return {};
+        pos = object.find_first_not_of(" \t\n\r\"", pos + 1);
+        if (pos == std::string::npos) return {};
+        size_t end = object.find_first_of(",}\"", pos);
+        return object.substr(pos, end - pos);
+    };
+
+    size_t begin = json.find('[');
+    while (begin != std::string::npos)
+    {
+        begin = json.find('{', begin);
+        if (begin == std::string::npos) break;
+        size_t end = json.find('}', begin);
+        if (end == std::string::npos) break;
+
+        std::string object = json.substr(begin, end - begin + 1);
+        std::string name = field(object, "name");
+        std::string triangles = field(object, "triangles");
+        std::string median = field(object, "median_ns");
+        if (!name.empty() && !triangles.empty() && !median.empty())
+        {
+            BenchResult result;
+            result.name = name;
+            result.triangles = std::strtoull(triangles.c_str(), nullptr, 10);
+            result.medianNs = std::atof(median.c_str());
+            result.spread = std::atof(field(object, "spread").c_str());
+            baseline[resultKey(result.name, result.triangles)] = result;
+        }
+        begin = end + 1;
+    }
+
+    // Anything else is most likely not a results file at all, which must not
+    // silently turn the regression check off.
+    return !baseline.empty();
+}
+
+// Returns false if any gated benchmark regressed, or has no baseline entry.
+bool compareWithBaseline(std::vector<BenchResult> const & results, std::map<std::string, BenchResult> const & baseline, Options const & options)
+{
+    bool passed = true;
+    std::printf("\nComparison with baseline (threshold %.1f%%, noise floor %.1f ns):\n", options.threshold * 100.0, options.noiseFloorNs);
+    for (BenchResult const & result : results)
+    {
+        std::string key = resultKey(result.name, result.triangles);
+        auto it = baseline.find(key);
+        if (it == baseline.end() || it->second.medianNs <= 0.0)
+        {
+            std::printf("  %-32s MISSING from baseline%s\n", key.c_str(), result.gated ? "" : " (not gated)");
+            passed = passed && !result.gated;
+            continue;
+        }
+
+        // On a noisy machine the medians of two identical runs drift apart
+        // by about their spreads, so those widen the allowed slowdown.
+        BenchResult const & base = it->second;
+        double change = result.medianNs / base.medianNs - 1.0;
+        double allowed = options.threshold + base.spread + result.spread;
+        bool regressed = result.gated
+            && change > allowed
+            && result.medianNs - base.medianNs > options.noiseFloorNs;
+        passed = passed && !regressed;
+        std::printf("  %-32s %+7.1f%%  allowed %+7.1f%%%s\n", key.c_str(),
+            change * 100.0, allowed * 100.0,
+            regressed ? "  REGRESSION" : (result.gated ? "" : "  (not gated)"));
+    }
+    return passed;
+}
+
+// Benchmarks
+
+// The indexed geometry must expand back to the exact input, and a grid has no
+// more distinct vertices than grid points. Otherwise a broken dedupe would
+// only show up as a speedup.
+bool checkDeduplication(std::vector<VertexAttributes> const & vertexData, std::vector<VertexAttributes> const & uniqueVertices, std::vector<uint32_t> const & indexData, uint64_t maxUniqueCount)
+{
+    if (indexData.size() != vertexData.size() || uniqueVertices.size() > maxUniqueCount)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < vertexData.size(); ++i)
+    {
+        if (indexData[i] >= uniqueVertices.size()
+            || std::memcmp(&uniqueVertices[indexData[i]], &vertexData[i], sizeof(VertexAttributes)) != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Returns false, without adding any result for this size, if an asset could
+// not be generated or loaded.
+bool benchGeometry(uint64_t triangleCount, Options const & options, std::vector<BenchResult> & results)
+{
+    GridMesh mesh(triangleCount);
+    fs::path objPath = options.assetDir / ("grid_" + std::to_string(triangleCount) + ".obj");
+    fs::path txtPath = options.assetDir / ("grid_" + std::to_string(triangleCount) + ".txt");
+    if (!generateObjAsset(objPath, mesh) || !generateTxtAsset(txtPath, triangleCount))
+    {
+        std::cerr << "Could not generate assets in " << options.assetDir << std::endl;
+        return false;
+    }
+
+    std::vector<BenchResult> sizeResults;
+    bool loaded = true;
+
+    std::vector<VertexAttributes> vertexData;
+    sizeResults.push_back(runBenchmark("parse_obj", triangleCount, options, [&]
+    {
+        loaded = loadGeometryFromObj(objPath, vertexData) && !vertexData.empty() && loaded;
+        benchSink = benchSink + vertexData.size();
+        return uint64_t(1);
+    }));
+    if (!loaded)
+    {
+        std::cerr << "Could not load " << objPath << std::endl;
+        return false;
+    }
+
+    sizeResults.push_back(runBenchmark("parse_txt", triangleCount, options, [&]
+    {
+        std::vector<float> pointData;
+        std::vector<uint16_t> indexData;
+        loaded = loadGeometry(txtPath, pointData, indexData, 6) && !indexData.empty() && loaded;
+        benchSink = benchSink + pointData.size() + indexData.size();
+        return uint64_t(1);
+    }));
+    if (!loaded)
+    {
+        std::cerr << "Could not load " << txtPath << std::endl;
+        return false;
+    }
+
+    std::vector<VertexAttributes> uniqueVertices;
+    std::vector<uint32_t> indexData;
+    sizeResults.push_back(runBenchmark("dedupe", triangleCount, options, [&]
+    {
+        deduplicateVertices(vertexData, uniqueVertices, indexData);
+        benchSink = benchSink + uniqueVertices.size() + indexData.size();
+        return uint64_t(1);
+    }));
+    if (!checkDeduplication(vertexData, uniqueVertices, indexData, mesh.VertexCount()))
+    {
+        std::cerr << "deduplicateVertices gave wrong results for " << objPath << std::endl;
+        return false;
+    }
+
+    // Stand-in for the CPU side of queue.writeBuffer() in
+    // Application::Initialize(): the data is copied into a staging allocation
+    // padded to 4 bytes. Reported for scale, but not gated.
+    std::vector<uint8_t> staging;
+    sizeResults.push_back(runBenchmark("upload_staging", triangleCount, options, [&]
+    {
+        size_t size = vertexData.size() * sizeof(VertexAttributes);
+        staging.resize((size + 3) & ~size_t(3));
+        std::memcpy(staging.data(), vertexData.data(), size);
+        benchSink = benchSink + staging[staging.size() / 2];
+        return uint64_t(1);
+    }));
+    sizeResults.back().gated = false;
+
+    results.insert(results.end(), sizeResults.begin(), sizeResults.end());
+    return true;
+}
+
+void benchFrame(Options const & options, std::vector<BenchResult> & results)
+{
+    constexpr uint64_t FramesPerSample = 10000;
+
+    MyUniforms uniforms{};
+    uniforms.color = { 0.0f, 1.0f, 0.4f, 1.0f };
+
+    results.push_back(runBenchmark("frame_matrices", 0, options, [&]
+    {
+        for (uint64_t frame = 0; frame < FramesPerSample; ++frame)
+        {
+            updateUniforms(uniforms, 1920, 1080);
+            uniforms.time += .01f;
+        }
+        benchSink = benchSink + uint64_t(uniforms.worldFromObject[0][0] * 1000.0f);
+        return FramesPerSample;
+    }));
+
+    // Stand-in for the two queue.writeBuffer() calls of Application::OnFrame().
+    // At a few ns per frame this is mostly noise, so it is not gated.
+    alignas(16) uint8_t staging[2][sizeof(MyUniforms)];
+    results.push_back(runBenchmark("uniform_packing", 0, options, [&]
+    {
+        for (uint64_t frame = 0; frame < FramesPerSample; ++frame)
+        {
+            uniforms.time += .01f;
+            std::memcpy(staging[0], &uniforms.worldFromObject, sizeof(MyUniforms::worldFromObject));
+            std::memcpy(staging[1], &uniforms, sizeof(MyUniforms));
+            benchSink = benchSink + staging[frame % 2][offsetof(MyUniforms, time)];
+        }
+        return FramesPerSample;
+    }));
+    results.back().gated = false;
+}
+
+// Times full frames (clear and draw) of one camera setup, and reports how much
+// of the frame the mesh covered.
+BenchResult benchRasterizerScene(std::string const & scene, std::vector<VertexAttributes> const & vertexData, MyUniforms const & uniforms,
+    SoftwareRasterizer & rasterizer, Options const & options)
+{
+    // The thread count is part of the name, results only compare between
+    // runs that used the same one.
+    std::string name = "rasterize_" + scene + "_" + std::to_string(options.rasterWidth) + "x" + std::to_string(options.rasterHeight)
+        + "_" + std::to_string(rasterizer.ThreadCount()) + "t";
+    BenchResult result = runBenchmark(name, vertexData.size() / 3, options, [&]
+    {
+        rasterizer.Clear({ .05f, .05f, .05f, 1.0f }, 1.0f);
+        rasterizer.Draw(vertexData, uniforms);
+        benchSink = benchSink + rasterizer.Pixels()[rasterizer.Pixels().size() / 2];
+        return uint64_t(1);
+    });
+
+    rasterizer.Clear({ .05f, .05f, .05f, 1.0f }, 1.0f);
+    uint32_t clearValue = rasterizer.Pixels()[0];
+    rasterizer.Draw(vertexData, uniforms);
+    size_t coveredCount = std::count_if(rasterizer.Pixels().begin(), rasterizer.Pixels().end(),
+        [clearValue](uint32_t pixel) { return pixel != clearValue; });
+    std::printf("%-24s covered %.2f%% of the frame\n", "", 100.0 * double(coveredCount) / double(rasterizer.Pixels().size()));
+
+    return result;
+}
+
+// Two scenes over the synthetic grid: the App camera, where the mesh only
+// covers a small part of the frame and most triangles are rejected before
+// binning, and a camera facing the grid so that it fills the viewport and
+// every stage (binning, edge functions, depth test, shading) is loaded.
+void benchRasterizer(uint64_t triangleCount, SoftwareRasterizer & rasterizer, Options const & options, std::vector<BenchResult> & results)
+{
+    GridMesh mesh(triangleCount);
+    std::vector<VertexAttributes> vertexData(3 * triangleCount);
+    uint64_t corners[3];
+    for (uint64_t t = 0; t < triangleCount; ++t)
+    {
+        mesh.Triangle(t, corners);
+        for (int i = 0; i < 3; ++i)
+        {
+            VertexAttributes & vertex = vertexData[3 * t + i];
+            mesh.Vertex(corners[i], &vertex.position.x, &vertex.normal.x, &vertex.color.x);
+        }
+    }
+
+    MyUniforms uniforms{};
+    uniforms.time = 1.0f;
+    uniforms.color = { 0.0f, 1.0f, 0.4f, 1.0f };
+    updateUniforms(uniforms, options.rasterWidth, options.rasterHeight);
+    results.push_back(benchRasterizerScene("app", vertexData, uniforms, rasterizer, options));
+
+    // Same projection, with the grid 2 units in front of the camera. At that
+    // distance the view is 2 units high, so a scale of 2.2 (times the aspect
+    // ratio horizontally) overscans the unit grid a little.
+    float ratio = float(options.rasterWidth) / float(options.rasterHeight);
+    uniforms.viewFromWorld = glm::translate(glm::mat4x4(1.0), glm::vec3(0.0, 0.0, 2.0));
+    uniforms.worldFromObject = glm::scale(glm::mat4x4(1.0), glm::vec3(2.2f * ratio, 2.2f, 1.0f));
+    results.push_back(benchRasterizerScene("fill", vertexData, uniforms, rasterizer, options));
+}
+
+int main(int argc, char ** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        return -1;
+    }
+
+    std::error_code error;
+    fs::create_directories(options.assetDir, error);
+    if (error)
+    {
+        std::cerr << "Could not create " << options.assetDir << ": " << error.message() << std::endl;
+        return -1;
+    }
+
+    std::vector<BenchResult> results;
+    benchFrame(options, results);
+    for (uint64_t size : options.sizes)
+    {
+        if (!benchGeometry(size, options, results))
+        {
+            return -1;
+        }
+    }
+
+    if (!options.rasterSizes.empty())
+    {
+        SoftwareRasterizer rasterizer(options.threadCount);
+        rasterizer.Resize(options.rasterWidth, options.rasterHeight);
+        for (uint64_t size : options.rasterSizes)
+        {
+            benchRasterizer(size, rasterizer, options, results);
+        }
+    }
+
+    if (!options.outputPath.empty() && !writeResults(options.outputPath, results))
+    {
+        std::cerr << "Could not write " << options.outputPath << std::endl;
+        return -1;
+    }
+
+    if (!options.baselinePath.empty())
+    {
+        std::map<std::string, BenchResult> baseline;
+        if (!readBaseline(options.baselinePath, baseline))
+        {
+            std::cerr << "Could not read any result from baseline " << options.baselinePath << std::endl;
+            return -1;
+        }
+        if (!compareWithBaseline(results, baseline, options))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
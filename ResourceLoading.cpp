@@ -1,12 +1,14 @@
 #include "ResourceLoading.h"
 
 #include "tiny_obj_loader.h"
-#include "webgpu/webgpu.hpp"
 
 #include <filesystem>
 #include <fstream>
+#include <iostream>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 
 namespace fs = std::filesystem;
 
@@ -120,24 +122,23 @@ bool loadGeometryFromObj(const fs::path& path, std::vector<VertexAttributes>& ve
 	return true;
 }
 
-wgpu::ShaderModule loadShaderModule(const fs::path& path, wgpu::Device device) {
-    std::ifstream file(path);
-    if (!file.is_open()) {
-        return nullptr;
-    }
-    file.seekg(0, std::ios::end);
-    size_t size = file.tellg();
-    std::string shaderSource(size, ' ');
-    file.seekg(0);
-    file.read(shaderSource.data(), size);
-
-    wgpu::ShaderModuleWGSLDescriptor shaderCodeDesc{};
-    shaderCodeDesc.chain.next = nullptr;
-    shaderCodeDesc.chain.sType = wgpu::SType::ShaderModuleWGSLDescriptor;
-    shaderCodeDesc.code = shaderSource.c_str();
-    wgpu::ShaderModuleDescriptor shaderDesc{};
-    shaderDesc.hintCount = 0;
-    shaderDesc.hints = nullptr;
-    shaderDesc.nextInChain = &shaderCodeDesc.chain;
-    return device.createShaderModule(shaderDesc);
+void deduplicateVertices(const std::vector<VertexAttributes>& vertexData, std::vector<VertexAttributes>& uniqueVertices, std::vector<uint32_t>& indexData) {
+	// VertexAttributes is just floats, so identical vertices are identical bytes
+	auto bytesOf = [](const VertexAttributes& vertex) {
+		return std::string_view(reinterpret_cast<const char*>(&vertex), sizeof(VertexAttributes));
+	};
+
+	uniqueVertices.clear();
+	indexData.clear();
+	indexData.reserve(vertexData.size());
+
+	std::unordered_map<std::string_view, uint32_t> vertexIndices;
+	vertexIndices.reserve(vertexData.size());
+	for (const auto& vertex : vertexData) {
+		auto [it, inserted] = vertexIndices.try_emplace(bytesOf(vertex), static_cast<uint32_t>(uniqueVertices.size()));
+		if (inserted) {
+			uniqueVertices.push_back(vertex);
+		}
+		indexData.push_back(it->second);
+	}
 }
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "webgpu/webgpu.hpp"
+
+#include <filesystem>
+
+wgpu::ShaderModule loadShaderModule(std::filesystem::path const & path, wgpu::Device device);
@@ -0,0 +1,524 @@
+#include "SoftwareRasterizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOFTWARE_RASTERIZER_SSE2 1
+#include <emmintrin.h>
+#else
+#define SOFTWARE_RASTERIZER_SSE2 0
+#endif
+
+namespace {
+
+constexpr uint32_t TrianglesPerBinMin = 1024;
+constexpr uint32_t BinsPerThread = 4;
+constexpr int MaxClipVertices = 9;
+// Vertex positions are snapped to 1/256th of a pixel, like most GPUs do.
+constexpr float SubpixelSteps = 256.0f;
+
+struct ClipVertex
+{
+    glm::vec4 position;
+    float varyings[6];
+};
+
+float encodeChannel(float linear, bool srgb)
+{
+    linear = linear > 0.0f ? (linear < 1.0f ? linear : 1.0f) : 0.0f;
+    if (srgb)
+    {
+        linear = linear <= 0.0031308f
+            ? 12.92f * linear
+            : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+    }
+    return linear;
+}
+
+uint32_t toUnorm8(float value)
+{
+    return uint32_t(value * 255.0f + 0.5f);
+}
+
+// Signed distance-like value of a clip space position to one of the clipping
+// planes, positive inside. Only near and far are clipped against: x and y are
+// handled by the scissoring in the rasterizer, which acts as a guard band.
+float planeDistance(glm::vec4 const & position, int plane)
+{
+    switch (plane)
+    {
+    case 0: return position.z;
+    case 1: return position.w - position.z;
+    default: return position.w - 1e-6f;
+    }
+}
+
+int clipPolygon(ClipVertex * polygon, int vertexCount, ClipVertex * scratch)
+{
+    for (int plane = 0; plane < 3 && vertexCount > 0; ++plane)
+    {
+        int outCount = 0;
+        for (int i = 0; i < vertexCount; ++i)
+        {
+            ClipVertex const & current = polygon[i];
+            ClipVertex const & next = polygon[(i + 1) % vertexCount];
+            float dCurrent = planeDistance(current.position, plane);
+            float dNext = planeDistance(next.position, plane);
+
+            if (dCurrent >= 0.0f)
+            {
+                scratch[outCount++] = current;
+            }
+            if ((dCurrent >= 0.0f) != (dNext >= 0.0f))
+            {
+                float t = dCurrent / (dCurrent - dNext);
+                ClipVertex & v = scratch[outCount++];
+                v.position = current.position + t * (next.position - current.position);
+                for (int k = 0; k < 6; ++k)
+                {
+                    v.varyings[k] = current.varyings[k] + t * (next.varyings[k] - current.varyings[k]);
+                }
+            }
+        }
+        std::copy(scratch, scratch + outCount, polygon);
+        vertexCount = outCount;
+    }
+    return vertexCount;
+}
+
+bool isInsideClipVolume(glm::vec4 const & position)
+{
+    return planeDistance(position, 0) >= 0.0f
+        && planeDistance(position, 1) >= 0.0f
+        && planeDistance(position, 2) >= 0.0f;
+}
+
+// fs_main from shader.wgsl, up to (but excluding) the output conversion.
+void shadeFragment(float const * varyings, float & r, float & g, float & b)
+{
+    float nx = varyings[0], ny = varyings[1], nz = varyings[2];
+    float invLength = 1.0f / std::sqrt(nx * nx + ny * ny + nz * nz);
+    nx *= invLength;
+    ny *= invLength;
+    nz *= invLength;
+
+    float shading1 = std::max(0.0f, 0.5f * nx - 0.9f * ny + 0.1f * nz);
+    float shading2 = std::max(0.0f, 0.2f * nx + 0.4f * ny + 0.3f * nz);
+
+    r = varyings[3] * (shading1 * 1.0f + shading2 * 0.6f);
+    g = varyings[4] * (shading1 * 0.9f + shading2 * 0.9f);
+    b = varyings[5] * (shading1 * 0.6f + shading2 * 1.0f);
+}
+
+} // namespace
+
+SoftwareRasterizer::SoftwareRasterizer(uint32_t threadCount)
+    : pool(threadCount)
+{
+    BuildColorLut();
+}
+
+void SoftwareRasterizer::Resize(uint32_t width, uint32_t height)
+{
+    this->width = width;
+    this->height = height;
+    tileCountX = (width + TileSize - 1) / TileSize;
+    tileCountY = (height + TileSize - 1) / TileSize;
+
+    colorBuffer.assign(size_t(width) * height, 0);
+    depthTiles.assign(size_t(tileCountX) * tileCountY * TileSize * TileSize, 1.0f);
+}
+
+void SoftwareRasterizer::Clear(std::array<float, 4> const & color, float depth)
+{
+    uint32_t clearValue =
+        toUnorm8(encodeChannel(color[0], srgbTarget))
+        | (toUnorm8(encodeChannel(color[1], srgbTarget)) << 8)
+        | (toUnorm8(encodeChannel(color[2], srgbTarget)) << 16)
+        | (toUnorm8(encodeChannel(color[3], false)) << 24);
+
+    pool.ParallelFor(tileCountX * tileCountY, [&](uint32_t tileIndex, uint32_t)
+    {
+        float * depthTile = depthTiles.data() + size_t(tileIndex) * TileSize * TileSize;
+        std::fill(depthTile, depthTile + TileSize * TileSize, depth);
+
+        uint32_t tileX = (tileIndex % tileCountX) * TileSize;
+        uint32_t tileY = (tileIndex / tileCountX) * TileSize;
+        uint32_t endX = std::min(tileX + TileSize, width);
+        uint32_t endY = std::min(tileY + TileSize, height);
+        for (uint32_t y = tileY; y < endY; ++y)
+        {
+            uint32_t * row = colorBuffer.data() + size_t(y) * width;
+            std::fill(row + tileX, row + endX, clearValue);
+        }
+    });
+}
+
+void SoftwareRasterizer::Draw(std::vector<VertexAttributes> const & vertexData, MyUniforms const & uniforms)
+{
+    uint32_t triangleCount = uint32_t(vertexData.size() / 3);
+    if (triangleCount == 0 || width == 0 || height == 0)
+    {
+        return;
+    }
+
+    if (colorLutSrgb != srgbTarget)
+    {
+        BuildColorLut();
+    }
+
+    binCount = std::min(pool.ThreadCount() * BinsPerThread, (triangleCount + TrianglesPerBinMin - 1) / TrianglesPerBinMin);
+    if (bins.size() < binCount)
+    {
+        bins.resize(binCount);
+    }
+
+    pool.ParallelFor(binCount, [&](uint32_t binIndex, uint32_t)
+    {
+        uint32_t first = uint32_t(uint64_t(triangleCount) * binIndex / binCount);
+        uint32_t last = uint32_t(uint64_t(triangleCount) * (binIndex + 1) / binCount);
+        SetupTriangles(bins[binIndex], vertexData.data() + 3 * size_t(first), last - first, uniforms);
+    });
+
+    pool.ParallelFor(tileCountX * tileCountY, [&](uint32_t tileIndex, uint32_t)
+    {
+        RasterizeTile(tileIndex);
+    });
+}
+
+void SoftwareRasterizer::SetupTriangles(Bin & bin, VertexAttributes const * vertices, uint32_t triangleCount, MyUniforms const & uniforms)
+{
+    bin.triangles.clear();
+    bin.tiles.resize(size_t(tileCountX) * tileCountY);
+    for (auto & tile : bin.tiles)
+    {
+        tile.clear();
+    }
+
+    // vs_main from shader.wgsl
+    glm::mat4x4 viewFromObject = uniforms.viewFromWorld * uniforms.worldFromObject;
+    glm::mat4x4 clipFromObject = uniforms.clipFromView * viewFromObject;
+
+    ClipVertex polygon[MaxClipVertices];
+    ClipVertex scratch[MaxClipVertices];
+
+    for (uint32_t t = 0; t < triangleCount; ++t)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            VertexAttributes const & in = vertices[3 * t + i];
+            ClipVertex & out = polygon[i];
+            out.position = clipFromObject * glm::vec4(in.position.x, in.position.y, in.position.z, 1.0f);
+            glm::vec4 normal = uniforms.worldFromObject * glm::vec4(in.normal.x, in.normal.y, in.normal.z, 0.0f);
+            out.varyings[0] = normal.x;
+            out.varyings[1] = normal.y;
+            out.varyings[2] = normal.z;
+            out.varyings[3] = in.color.x;
+            out.varyings[4] = in.color.y;
+            out.varyings[5] = in.color.z;
+        }
+
+        // Trivially reject triangles entirely outside one of the side planes
+        bool outside = false;
+        for (int axis = 0; axis < 2 && !outside; ++axis)
+        {
+            outside =
+                (polygon[0].position[axis] > polygon[0].position.w && polygon[1].position[axis] > polygon[1].position.w && polygon[2].position[axis] > polygon[2].position.w)
+                || (polygon[0].position[axis] < -polygon[0].position.w && polygon[1].position[axis] < -polygon[1].position.w && polygon[2].position[axis] < -polygon[2].position.w);
+        }
+        if (outside)
+        {
+            continue;
+        }
+
+        int vertexCount = 3;
+        if (!isInsideClipVolume(polygon[0].position) || !isInsideClipVolume(polygon[1].position) || !isInsideClipVolume(polygon[2].position))
+        {
+            vertexCount = clipPolygon(polygon, vertexCount, scratch);
+        }
+
+        // Project to screen space: x right, y down, z in [0, 1]
+        float sx[MaxClipVertices], sy[MaxClipVertices], sz[MaxClipVertices], invW[MaxClipVertices];
+        for (int i = 0; i < vertexCount; ++i)
+        {
+            glm::vec4 const & p = polygon[i].position;
+            invW[i] = 1.0f / p.w;
+            sx[i] = std::round((p.x * invW[i] * 0.5f + 0.5f) * float(width) * SubpixelSteps) / SubpixelSteps;
+            sy[i] = std::round((0.5f - p.y * invW[i] * 0.5f) * float(height) * SubpixelSteps) / SubpixelSteps;
+            sz[i] = p.z * invW[i];
+        }
+
+        // Triangle fan over the clipped polygon
+        for (int k = 1; k + 1 < vertexCount; ++k)
+        {
+            int const corners[3] = { 0, k, k + 1 };
+
+            float minSX = std::min({ sx[corners[0]], sx[corners[1]], sx[corners[2]] });
+            float maxSX = std::max({ sx[corners[0]], sx[corners[1]], sx[corners[2]] });
+            float minSY = std::min({ sy[corners[0]], sy[corners[1]], sy[corners[2]] });
+            float maxSY = std::max({ sy[corners[0]], sy[corners[1]], sy[corners[2]] });
+
+            // Pixel x is covered when its center x + 0.5 is inside. Clamp as
+            // floats first, far off-screen vertices would overflow an int.
+            SetupTriangle tri;
+            tri.minX = int(std::clamp(std::ceil(minSX - 0.5f), 0.0f, float(width)));
+            tri.minY = int(std::clamp(std::ceil(minSY - 0.5f), 0.0f, float(height)));
+            tri.maxX = int(std::clamp(std::floor(maxSX - 0.5f), -1.0f, float(width) - 1.0f));
+            tri.maxY = int(std::clamp(std::floor(maxSY - 0.5f), -1.0f, float(height) - 1.0f));
+            if (tri.minX > tri.maxX || tri.minY > tri.maxY)
+            {
+                continue;
+            }
+
+            // Edge functions are expressed relative to the bounding box
+            // corner, which keeps them precise for small triangles far from
+            // the screen origin.
+            double area = 0.0;
+            for (int i = 0; i < 3; ++i)
+            {
+                int from = corners[(i + 1) % 3];
+                int to = corners[(i + 2) % 3];
+                double ax = double(sx[from]) - tri.minX, ay = double(sy[from]) - tri.minY;
+                double a = double(sy[from]) - double(sy[to]);
+                double b = double(sx[to]) - double(sx[from]);
+                tri.a[i] = float(a);
+                tri.b[i] = float(b);
+                tri.c[i] = float(-(a * ax + b * ay));
+                if (i == 0)
+                {
+                    double vx = double(sx[corners[0]]) - tri.minX, vy = double(sy[corners[0]]) - tri.minY;
+                    area = a * vx + b * vy - (a * ax + b * ay);
+                }
+            }
+            if (area == 0.0)
+            {
+                continue;
+            }
+            if (area < 0.0)
+            {
+                // No culling: flip clockwise triangles so inside is positive
+                for (int i = 0; i < 3; ++i)
+                {
+                    tri.a[i] = -tri.a[i];
+                    tri.b[i] = -tri.b[i];
+                    tri.c[i] = -tri.c[i];
+                }
+                area = -area;
+            }
+            tri.invArea = float(1.0 / area);
+
+            for (int i = 0; i < 3; ++i)
+            {
+                tri.topLeft[i] = tri.a[i] > 0.0f || (tri.a[i] == 0.0f && tri.b[i] > 0.0f);
+
+                int corner = corners[i];
+                tri.z[i] = sz[corner];
+                tri.invW[i] = invW[corner];
+                for (int v = 0; v < 6; ++v)
+                {
+                    tri.varyings[i][v] = polygon[corner].varyings[v] * invW[corner];
+                }
+            }
+
+            uint32_t triangleIndex = uint32_t(bin.triangles.size());
+            bin.triangles.push_back(tri);
+
+            for (uint32_t ty = uint32_t(tri.minY) / TileSize; ty <= uint32_t(tri.maxY) / TileSize; ++ty)
+            {
+                for (uint32_t tx = uint32_t(tri.minX) / TileSize; tx <= uint32_t(tri.maxX) / TileSize; ++tx)
+                {
+                    bin.tiles[ty * tileCountX + tx].push_back(triangleIndex);
+                }
+            }
+        }
+    }
+}
+
+void SoftwareRasterizer::RasterizeTile(uint32_t tileIndex)
+{
+    int tileX = int(tileIndex % tileCountX * TileSize);
+    int tileY = int(tileIndex / tileCountX * TileSize);
+
+    // Walking bins in order preserves the submission order of triangles,
+    // which decides the winner between fragments of equal depth.
+    for (uint32_t binIndex = 0; binIndex < binCount; ++binIndex)
+    {
+        Bin const & bin = bins[binIndex];
+        for (uint32_t triangleIndex : bin.tiles[tileIndex])
+        {
+            RasterizeTriangle(bin.triangles[triangleIndex], tileIndex, tileX, tileY);
+        }
+    }
+}
+
+void SoftwareRasterizer::RasterizeTriangle(SetupTriangle const & tri, uint32_t tileIndex, int tileX, int tileY)
+{
+    int startX = std::max(tri.minX, tileX);
+    int startY = std::max(tri.minY, tileY);
+    int endX = std::min(tri.maxX, tileX + int(TileSize) - 1);
+    int endY = std::min(tri.maxY, tileY + int(TileSize) - 1);
+
+    float * depthTile = depthTiles.data() + size_t(tileIndex) * TileSize * TileSize;
+
+    // Pixels are processed in aligned groups of 4 along a row. Tiles are a
+    // multiple of 4 wide, so a group never leaves the depth tile, but lanes
+    // outside [startX, endX] have to be masked out.
+    int groupStartX = tileX + ((startX - tileX) & ~3);
+
+    for (int y = startY; y <= endY; ++y)
+    {
+        float py = float(y - tri.minY) + 0.5f;
+        float rowBase[3];
+        for (int i = 0; i < 3; ++i)
+        {
+            rowBase[i] = tri.b[i] * py + tri.c[i];
+        }
+
+        float * depthRow = depthTile + (y - tileY) * TileSize;
+        uint32_t * colorRow = colorBuffer.data() + size_t(y) * width;
+
+        for (int x = groupStartX; x <= endX; x += 4)
+        {
+            float weights[3][4];
+            int mask = 0;
+
+            float px = float(x - tri.minX) + 0.5f;
+
+#if SOFTWARE_RASTERIZER_SSE2
+            __m128 const zero = _mm_setzero_ps();
+            __m128 lanePx = _mm_add_ps(_mm_set1_ps(px), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f));
+            __m128i laneX = _mm_add_epi32(_mm_set1_epi32(x), _mm_setr_epi32(0, 1, 2, 3));
+            __m128 inside = _mm_castsi128_ps(_mm_and_si128(
+                _mm_cmpgt_epi32(laneX, _mm_set1_epi32(startX - 1)),
+                _mm_cmplt_epi32(laneX, _mm_set1_epi32(endX + 1))));
+
+            __m128 edge[3];
+            for (int i = 0; i < 3; ++i)
+            {
+                edge[i] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.a[i]), lanePx), _mm_set1_ps(rowBase[i]));
+                __m128 covered = tri.topLeft[i] ? _mm_cmpge_ps(edge[i], zero) : _mm_cmpgt_ps(edge[i], zero);
+                inside = _mm_and_ps(inside, covered);
+            }
+            if (_mm_movemask_ps(inside) == 0)
+            {
+                continue;
+            }
+
+            __m128 invArea = _mm_set1_ps(tri.invArea);
+            __m128 z = zero;
+            for (int i = 0; i < 3; ++i)
+            {
+                __m128 weight = _mm_mul_ps(edge[i], invArea);
+                z = _mm_add_ps(z, _mm_mul_ps(weight, _mm_set1_ps(tri.z[i])));
+                _mm_storeu_ps(weights[i], weight);
+            }
+
+            // Depth test `Less`, with depth writes enabled
+            float * depthGroup = depthRow + (x - tileX);
+            __m128 storedDepth = _mm_loadu_ps(depthGroup);
+            inside = _mm_and_ps(inside, _mm_cmplt_ps(z, storedDepth));
+            _mm_storeu_ps(depthGroup, _mm_or_ps(_mm_and_ps(inside, z), _mm_andnot_ps(inside, storedDepth)));
+            mask = _mm_movemask_ps(inside);
+#else
+            float * depthGroup = depthRow + (x - tileX);
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                int laneX = x + lane;
+                if (laneX < startX || laneX > endX)
+                {
+                    continue;
+                }
+
+                bool covered = true;
+                float z = 0.0f;
+                for (int i = 0; i < 3; ++i)
+                {
+                    float edge = tri.a[i] * (px + float(lane)) + rowBase[i];
+                    covered = covered && (tri.topLeft[i] ? edge >= 0.0f : edge > 0.0f);
+                    weights[i][lane] = edge * tri.invArea;
+                    z += weights[i][lane] * tri.z[i];
+                }
+
+                if (covered && z < depthGroup[lane])
+                {
+                    depthGroup[lane] = z;
+                    mask |= 1 << lane;
+                }
+            }
+#endif
+
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                if ((mask & (1 << lane)) == 0)
+                {
+                    continue;
+                }
+
+                // Perspective-correct interpolation of the varyings
+                float l0 = weights[0][lane], l1 = weights[1][lane], l2 = weights[2][lane];
+                float w = 1.0f / (l0 * tri.invW[0] + l1 * tri.invW[1] + l2 * tri.invW[2]);
+                float varyings[6];
+                for (int v = 0; v < 6; ++v)
+                {
+                    varyings[v] = (l0 * tri.varyings[0][v] + l1 * tri.varyings[1][v] + l2 * tri.varyings[2][v]) * w;
+                }
+
+                float r, g, b;
+                shadeFragment(varyings, r, g, b);
+
+                // The blend state only keeps the destination alpha
+                uint32_t & pixel = colorRow[x + lane];
+                pixel = EncodeColor(r, g, b, pixel >> 24);
+            }
+        }
+    }
+}
+
+void SoftwareRasterizer::BuildColorLut()
+{
+    // fs_main ends with pow(color, 2.2); fold it and the target encoding into
+    // one table over the pre-pow color.
+    for (size_t i = 0; i < colorLut.size(); ++i)
+    {
+        float color = float(i) / float(colorLut.size() - 1);
+        colorLut[i] = uint8_t(toUnorm8(encodeChannel(std::pow(color, 2.2f), srgbTarget)));
+    }
+    colorLutSrgb = srgbTarget;
+}
+
+uint32_t SoftwareRasterizer::EncodeColor(float r, float g, float b, uint32_t alpha) const
+{
+    auto lookup = [this](float color)
+    {
+        color = color > 0.0f ? (color < 1.0f ? color : 1.0f) : 0.0f;
+        return uint32_t(colorLut[size_t(color * float(colorLut.size() - 1) + 0.5f)]);
+    };
+    return lookup(r) | (lookup(g) << 8) | (lookup(b) << 16) | (alpha << 24);
+}
+
+bool SoftwareRasterizer::SaveImage(std::filesystem::path const & path) const
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    // Binary PPM, which any image tool can read and diff
+    file << "P6\n" << width << " " << height << "\n255\n";
+    std::vector<char> row(size_t(width) * 3);
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            uint32_t pixel = colorBuffer[size_t(y) * width + x];
+            row[3 * x + 0] = char(pixel & 0xff);
+            row[3 * x + 1] = char((pixel >> 8) & 0xff);
+            row[3 * x + 2] = char((pixel >> 16) & 0xff);
+        }
+        file.write(row.data(), row.size());
+    }
+    return bool(file);
+}
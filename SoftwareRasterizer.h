@@ -0,0 +1,94 @@
+#pragma once
+
+#include "ThreadPool.h"
+#include "Uniforms.h"
+#include "VertexAttributes.h"
+
+#include <array>
+#include <filesystem>
+#include <stdint.h>
+#include <vector>
+
+// CPU implementation of the render pipeline built in Application::Initialize():
+// a non-indexed triangle list of VertexAttributes, vs_main/fs_main from
+// shader.wgsl, no culling, and a `Less` depth test. Used to produce reference
+// images on machines without a GPU.
+//
+// Triangles are transformed and binned into screen tiles in parallel, then
+// each tile is rasterized by a single thread against its own depth tile, so
+// tiles never need to synchronize with each other.
+class SoftwareRasterizer
+{
+public:
+    static constexpr uint32_t TileSize = 64;
+
+    // A threadCount of 0 uses all hardware threads.
+    explicit SoftwareRasterizer(uint32_t threadCount = 0);
+
+    // Mirrors the surface format: when true, colors are encoded to sRGB on
+    // write like a *Srgb swap chain format does.
+    bool srgbTarget = true;
+
+    void Resize(uint32_t width, uint32_t height);
+
+    // Same semantics as the render pass clear: the color is linear.
+    void Clear(std::array<float, 4> const & color, float depth);
+
+    void Draw(std::vector<VertexAttributes> const & vertexData, MyUniforms const & uniforms);
+
+    uint32_t ThreadCount() const { return pool.ThreadCount(); }
+    uint32_t Width() const { return width; }
+    uint32_t Height() const { return height; }
+
+    // Row-major RGBA8 pixels, red in the lowest byte.
+    std::vector<uint32_t> const & Pixels() const { return colorBuffer; }
+
+    bool SaveImage(std::filesystem::path const & path) const;
+
+private:
+    // Screen-space triangle ready for rasterization.
+    struct SetupTriangle
+    {
+        // Edge functions a * x + b * y + c, positive inside. Edge i is the one
+        // facing vertex i, so it yields that vertex's barycentric weight.
+        float a[3], b[3], c[3];
+        // Whether a pixel center lying exactly on edge i is covered.
+        bool topLeft[3];
+        float invArea;
+        int minX, minY, maxX, maxY;
+        float z[3];
+        float invW[3];
+        // normal.xyz and color.xyz, pre-divided by w
+        float varyings[3][6];
+    };
+
+    // Triangles set up by one slice of the vertex buffer, and the tiles they touch.
+    struct Bin
+    {
+        std::vector<SetupTriangle> triangles;
+        std::vector<std::vector<uint32_t>> tiles;
+    };
+
+    void SetupTriangles(Bin & bin, VertexAttributes const * vertices, uint32_t triangleCount, MyUniforms const & uniforms);
+    void RasterizeTile(uint32_t tileIndex);
+    void RasterizeTriangle(SetupTriangle const & triangle, uint32_t tileIndex, int tileX, int tileY);
+
+    void BuildColorLut();
+    uint32_t EncodeColor(float r, float g, float b, uint32_t alpha) const;
+
+    ThreadPool pool;
+
+    uint32_t width = 0, height = 0;
+    uint32_t tileCountX = 0, tileCountY = 0;
+
+    std::vector<uint32_t> colorBuffer;
+    // One TileSize * TileSize block per tile, so a tile's depth stays in cache
+    // while it is being rasterized.
+    std::vector<float> depthTiles;
+    std::vector<Bin> bins;
+    uint32_t binCount = 0;
+
+    // Maps a shaded linear color channel in [0, 1] to its 8-bit stored value.
+    std::array<uint8_t, 4097> colorLut{};
+    bool colorLutSrgb = false;
+};
@@ -0,0 +1,186 @@
+#include "ResourceLoading.h"
+#include "SoftwareRasterizer.h"
+#include "Uniforms.h"
+#include "VertexAttributes.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Headless counterpart of App: renders the same scene with SoftwareRasterizer
+// and either writes it out or compares it against a reference
+// image, e.g. one captured with App --capture.
+//
+//   SoftwareRender [--obj path] [--width w] [--height h] [--time t]
+//                  [--threads n] [--frames n] [--output image.ppm]
+//                  [--compare golden.ppm] [--tolerance t] [--max-mismatch f]
+
+struct Options
+{
+    std::string objPath = RESOURCE_DIR "/pyramid.obj";
+    uint32_t width = 640, height = 480;
+    float time = 0.0f;
+    uint32_t threadCount = 0;
+    int frameCount = 1;
+    std::string outputPath;
+    std::string comparePath;
+    // Largest per-channel difference for a pixel to still count as matching
+    int tolerance = 2;
+    // Fraction of pixels allowed to differ beyond the tolerance, to absorb
+    // rasterization differences along triangle edges.
+    double maxMismatch = 0.001;
+};
+
+bool parseOptions(int argc, char ** argv, Options & options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        char const * arg = argv[i];
+        char const * value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (value == nullptr)
+        {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        }
+        ++i;
+
+        if (std::strcmp(arg, "--obj") == 0) options.objPath = value;
+        else if (std::strcmp(arg, "--width") == 0) options.width = uint32_t(std::atoi(value));
+        else if (std::strcmp(arg, "--height") == 0) options.height = uint32_t(std::atoi(value));
+        else if (std::strcmp(arg, "--time") == 0) options.time = float(std::atof(value));
+        else if (std::strcmp(arg, "--threads") == 0) options.threadCount = uint32_t(std::atoi(value));
+        else if (std::strcmp(arg, "--frames") == 0) options.frameCount = std::atoi(value);
+        else if (std::strcmp(arg, "--output") == 0) options.outputPath = value;
+        else if (std::strcmp(arg, "--compare") == 0) options.comparePath = value;
+        else if (std::strcmp(arg, "--tolerance") == 0) options.tolerance = std::atoi(value);
+        else if (std::strcmp(arg, "--max-mismatch") == 0) options.maxMismatch = std::atof(value);
+        else
+        {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if (options.width == 0 || options.height == 0 || options.frameCount < 1)
+    {
+        std::cerr << "Invalid image size or frame count" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Reads a binary PPM (P6, 8 bits per channel) as written by SaveImage().
+bool loadImage(std::string const & path, uint32_t & width, uint32_t & height, std::vector<uint8_t> & rgb)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    std::string magic;
+    int maxValue = 0;
+    file >> magic >> width >> height >> maxValue;
+    if (!file || magic != "P6" || maxValue != 255)
+    {
+        return false;
+    }
+    file.get(); // single whitespace before the pixel data
+
+    rgb.resize(size_t(width) * height * 3);
+    file.read(reinterpret_cast<char *>(rgb.data()), rgb.size());
+    return bool(file);
+}
+
+bool compareWithGolden(SoftwareRasterizer const & rasterizer, Options const & options)
+{
+    uint32_t goldenWidth, goldenHeight;
+    std::vector<uint8_t> golden;
+    if (!loadImage(options.comparePath, goldenWidth, goldenHeight, golden))
+    {
+        std::cerr << "Could not load golden image " << options.comparePath << std::endl;
+        return false;
+    }
+    if (goldenWidth != rasterizer.Width() || goldenHeight != rasterizer.Height())
+    {
+        std::cerr << "Golden image is " << goldenWidth << "x" << goldenHeight
+            << ", rendered " << rasterizer.Width() << "x" << rasterizer.Height() << std::endl;
+        return false;
+    }
+
+    std::vector<uint32_t> const & pixels = rasterizer.Pixels();
+    size_t mismatchCount = 0;
+    int maxDifference = 0;
+    for (size_t i = 0; i < pixels.size(); ++i)
+    {
+        int pixelDifference = 0;
+        for (int channel = 0; channel < 3; ++channel)
+        {
+            int rendered = int((pixels[i] >> (8 * channel)) & 0xff);
+            pixelDifference = std::max(pixelDifference, std::abs(rendered - int(golden[3 * i + channel])));
+        }
+        maxDifference = std::max(maxDifference, pixelDifference);
+        if (pixelDifference > options.tolerance)
+        {
+            ++mismatchCount;
+        }
+    }
+
+    double mismatch = double(mismatchCount) / double(pixels.size());
+    std::cout << "Mismatching pixels: " << mismatchCount << " (" << mismatch * 100.0 << "%), "
+        << "max channel difference: " << maxDifference << std::endl;
+    return mismatch <= options.maxMismatch;
+}
+
+int main(int argc, char ** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        return -1;
+    }
+
+    std::vector<VertexAttributes> vertexData;
+    if (!loadGeometryFromObj(options.objPath, vertexData))
+    {
+        std::cerr << "Could not load geometry!" << std::endl;
+        return -1;
+    }
+
+    MyUniforms uniforms{};
+    uniforms.time = options.time;
+    uniforms.color = { 0.0f, 1.0f, 0.4f, 1.0f };
+    updateUniforms(uniforms, options.width, options.height);
+
+    SoftwareRasterizer rasterizer(options.threadCount);
+    rasterizer.Resize(options.width, options.height);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < options.frameCount; ++frame)
+    {
+        rasterizer.Clear({ .05f, .05f, .05f, 1.0f }, 1.0f);
+        rasterizer.Draw(vertexData, uniforms);
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << vertexData.size() / 3 << " triangles at " << options.width << "x" << options.height
+        << ": " << elapsed.count() / options.frameCount << " ms per frame" << std::endl;
+
+    if (!options.outputPath.empty() && !rasterizer.SaveImage(options.outputPath))
+    {
+        std::cerr << "Could not write " << options.outputPath << std::endl;
+        return -1;
+    }
+
+    if (!options.comparePath.empty() && !compareWithGolden(rasterizer, options))
+    {
+        return 1;
+    }
+
+    return 0;
+}
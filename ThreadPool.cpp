@@ -0,0 +1,170 @@
+#include "ThreadPool.h"
+
+namespace {
+
+uint64_t packRange(uint32_t begin, uint32_t end)
+{
+    return (uint64_t(begin) << 32) | end;
+}
+
+uint32_t rangeBegin(uint64_t range)
+{
+    return uint32_t(range >> 32);
+}
+
+uint32_t rangeEnd(uint64_t range)
+{
+    return uint32_t(range);
+}
+
+} // namespace
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::thread::hardware_concurrency();
+    }
+    this->threadCount = threadCount > 0 ? threadCount : 1;
+
+    ranges = std::make_unique<WorkRange[]>(this->threadCount);
+    for (uint32_t i = 0; i < this->threadCount; ++i)
+    {
+        ranges[i].range.store(packRange(0, 0));
+    }
+
+    // The calling thread acts as worker 0.
+    for (uint32_t i = 1; i < this->threadCount; ++i)
+    {
+        workers.emplace_back(&ThreadPool::WorkerMain, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    jobStarted.notify_all();
+
+    for (auto & worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::ParallelFor(uint32_t count, std::function<void(uint32_t, uint32_t)> const & job)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    if (workers.empty() || count == 1)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            job(i, 0);
+        }
+        return;
+    }
+
+    // Hand out contiguous slices so that neighbouring indices (e.g. screen
+    // tiles) tend to stay on the same thread until stealing kicks in.
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        uint32_t begin = uint32_t(uint64_t(count) * i / threadCount);
+        uint32_t end = uint32_t(uint64_t(count) * (i + 1) / threadCount);
+        ranges[i].range.store(packRange(begin, end), std::memory_order_relaxed);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->job = &job;
+        busyWorkers = uint32_t(workers.size());
+        ++generation;
+    }
+    jobStarted.notify_all();
+
+    RunJob(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    jobFinished.wait(lock, [this] { return busyWorkers == 0; });
+    this->job = nullptr;
+}
+
+void ThreadPool::WorkerMain(uint32_t threadIndex)
+{
+    uint64_t seenGeneration = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobStarted.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping)
+            {
+                return;
+            }
+            seenGeneration = generation;
+        }
+
+        RunJob(threadIndex);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --busyWorkers;
+        }
+        jobFinished.notify_one();
+    }
+}
+
+void ThreadPool::RunJob(uint32_t threadIndex)
+{
+    uint32_t index;
+    while (PopIndex(threadIndex, index) || StealIndex(threadIndex, index))
+    {
+        (*job)(index, threadIndex);
+    }
+}
+
+bool ThreadPool::PopIndex(uint32_t threadIndex, uint32_t & index)
+{
+    std::atomic<uint64_t> & own = ranges[threadIndex].range;
+    uint64_t range = own.load(std::memory_order_acquire);
+    while (rangeBegin(range) < rangeEnd(range))
+    {
+        if (own.compare_exchange_weak(range, packRange(rangeBegin(range) + 1, rangeEnd(range)), std::memory_order_acq_rel))
+        {
+            index = rangeBegin(range);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::StealIndex(uint32_t threadIndex, uint32_t & index)
+{
+    for (uint32_t offset = 1; offset < threadCount; ++offset)
+    {
+        std::atomic<uint64_t> & victim = ranges[(threadIndex + offset) % threadCount].range;
+        uint64_t range = victim.load(std::memory_order_acquire);
+        while (rangeBegin(range) < rangeEnd(range))
+        {
+            // Take the back half, leaving the victim the front it is working
+            // towards. A single remaining index is taken whole.
+            uint32_t begin = rangeBegin(range);
+            uint32_t end = rangeEnd(range);
+            uint32_t middle = begin + (end - begin) / 2;
+            if (victim.compare_exchange_weak(range, packRange(begin, middle), std::memory_order_acq_rel))
+            {
+                // Our own range is empty, and thieves never touch an empty
+                // range, so a plain store is enough here.
+                ranges[threadIndex].range.store(packRange(middle + 1, end), std::memory_order_release);
+                index = middle;
+                return true;
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads running index-parallel loops.
+//
+// ParallelFor() splits [0, count) into one contiguous range per thread. Each
+// thread pops indices from the front of its own range and, once it runs dry,
+// steals the back half of another thread's range. A range is packed into a
+// single 64-bit atomic, so both popping and stealing are one compare-exchange.
+class ThreadPool
+{
+public:
+    // A threadCount of 0 uses std::thread::hardware_concurrency().
+    explicit ThreadPool(uint32_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool const &) = delete;
+    ThreadPool & operator=(ThreadPool const &) = delete;
+
+    // Number of threads taking part in a ParallelFor(), including the caller.
+    uint32_t ThreadCount() const { return threadCount; }
+
+    // Calls job(index, threadIndex) for every index in [0, count) and blocks
+    // until all calls have returned. threadIndex is in [0, ThreadCount()).
+    void ParallelFor(uint32_t count, std::function<void(uint32_t, uint32_t)> const & job);
+
+private:
+    struct alignas(64) WorkRange
+    {
+        std::atomic<uint64_t> range;
+    };
+
+    void WorkerMain(uint32_t threadIndex);
+    void RunJob(uint32_t threadIndex);
+    bool PopIndex(uint32_t threadIndex, uint32_t & index);
+    bool StealIndex(uint32_t threadIndex, uint32_t & index);
+
+    uint32_t threadCount = 1;
+    std::vector<std::thread> workers;
+    std::unique_ptr<WorkRange[]> ranges;
+
+    std::mutex mutex;
+    std::condition_variable jobStarted;
+    std::condition_variable jobFinished;
+    std::function<void(uint32_t, uint32_t)> const * job = nullptr;
+    uint64_t generation = 0;
+    uint32_t busyWorkers = 0;
+    bool stopping = false;
+};
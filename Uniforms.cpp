@@ -0,0 +1,29 @@
+#include "Uniforms.h"
+
+#include "glm/ext.hpp"
+
+void updateUniforms(MyUniforms & uniforms, uint32_t width, uint32_t height)
+{
+    // Model matrix
+    float angle1 = 2.0f * uniforms.time;
+    glm::mat4x4 S = glm::scale(glm::mat4x4(1.0), glm::vec3(0.3f));
+    glm::mat4x4 T1 = glm::translate(glm::mat4x4(1.0), glm::vec3(0.5, 0.0, 0.0));
+
+    // View matrix
+    float angle2 = 3.0f * 3.14159f / 4.0f;
+    glm::vec3 focalPoint(0.0, 0.0, -2.0);
+    glm::mat4x4 R2 = glm::rotate(glm::mat4x4(1.0), -angle2, glm::vec3(1.0, 0.0, 0.0));
+    glm::mat4x4 T2 = glm::translate(glm::mat4x4(1.0), -focalPoint);
+    uniforms.viewFromWorld = T2 * R2;
+
+    // Projection matrix
+    float ratio = float(width) / float(height);
+    float near = 0.01f;
+    float far = 100.0f;
+    float focalLength = 2.0f;
+    float fov = 2 * glm::atan(1 / focalLength);
+    uniforms.clipFromView = glm::perspective(fov, ratio, near, far);
+
+    auto R1 = glm::rotate(glm::mat4x4(1.0), angle1, glm::vec3(0.0, 0.0, 1.0));
+    uniforms.worldFromObject = R1 * T1 * S;
+}
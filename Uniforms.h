@@ -0,0 +1,24 @@
+#pragma once
+
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_FORCE_LEFT_HANDED
+#include "glm/glm.hpp"
+
+#include <array>
+#include <stdint.h>
+
+struct MyUniforms
+{
+    glm::mat4x4 clipFromView;
+    glm::mat4x4 viewFromWorld;
+    glm::mat4x4 worldFromObject;
+    std::array<float, 4> color;
+    float time;
+    float _pad[3];
+};
+
+static_assert(sizeof(MyUniforms) % 16 == 0);
+
+// Fills in the model, view and projection matrices for the current time and
+// framebuffer size. Shared by the WebGPU and software rendering paths.
+void updateUniforms(MyUniforms & uniforms, uint32_t width, uint32_t height);
@@ -1,15 +1,18 @@
 #include "ResourceLoading.h"
+#include "ShaderLoading.h"
+#include "Uniforms.h"
 #include "VertexAttributes.h"
 
 #include "glfw3webgpu.h"
 #include "GLFW/glfw3.h"
-#define GLM_FORCE_DEPTH_ZERO_TO_ONE
-#define GLM_FORCE_LEFT_HANDED
-#include "glm/glm.hpp"
-#include "glm/ext.hpp"
 #include "webgpu/webgpu.hpp"
+#include "webgpu/wgpu.h"
 
 #include <array>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <vector>
 
@@ -25,18 +28,6 @@ constexpr IntT Align(IntT n, SizeT alignment)
     return IntT((n + alignmentMask) & ~alignmentMask);
 }
 
-struct MyUniforms
-{
-    glm::mat4x4 clipFromView;
-    glm::mat4x4 viewFromWorld;
-    glm::mat4x4 worldFromObject;
-    std::array<float, 4> color;
-    float time;
-    float _pad[3];
-};
-
-static_assert(sizeof(MyUniforms) % 16 == 0);
-
 struct Application
 {
     bool Initialize();
@@ -56,6 +47,17 @@ struct Application
 
     void BuildSwapChain();
     void BuildDepthBuffer();
+    void BuildCaptureTarget();
+
+    void RenderFrame(wgpu::TextureView target);
+
+    // Renders one frame offscreen and writes it as a binary PPM, in the same
+    // format as SoftwareRasterizer::SaveImage(). Requires headless mode.
+    bool CaptureFrame(std::filesystem::path const & path);
+
+    // Set before Initialize() to render without a window, to captureTexture
+    // instead of a swap chain.
+    bool headless = false;
 
     GLFWwindow * window = nullptr;
     wgpu::Instance instance = nullptr;
@@ -72,6 +74,8 @@ struct Application
     wgpu::Buffer vertexBuffer = nullptr;
     wgpu::Buffer uniformBuffer = nullptr;
     wgpu::BindGroup bindGroup = nullptr;
+    wgpu::Texture captureTexture = nullptr;
+    wgpu::TextureView captureTextureView = nullptr;
 
     uint32_t windowWidth = 640, windowHeight = 480;
 
@@ -83,19 +87,22 @@ struct Application
 
 bool Application::Initialize()
 {
-    if (!glfwInit())
+    if (!headless)
     {
-        std::cerr << "Could not initialize GLFW!\n";
-        return false;
-    }
-
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    window = glfwCreateWindow(windowWidth, windowHeight, "Learn WebGPU", NULL, NULL);
-    if (!window)
-    {
-        std::cerr << "Could not open window!\n";
-        glfwTerminate();
-        return false;
+        if (!glfwInit())
+        {
+            std::cerr << "Could not initialize GLFW!\n";
+            return false;
+        }
+
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        window = glfwCreateWindow(windowWidth, windowHeight, "Learn WebGPU", NULL, NULL);
+        if (!window)
+        {
+            std::cerr << "Could not open window!\n";
+            glfwTerminate();
+            return false;
+        }
     }
 
     wgpu::InstanceDescriptor desc{};
@@ -121,7 +128,10 @@ bool Application::Initialize()
 
     // surface = instance.createSurface(surfaceDescriptor);
 
-    surface = glfwGetWGPUSurface(instance, window);
+    if (!headless)
+    {
+        surface = glfwGetWGPUSurface(instance, window);
+    }
 
     wgpu::RequestAdapterOptions adapterOptions{};
     adapterOptions.compatibleSurface = surface;
@@ -190,7 +200,14 @@ bool Application::Initialize()
     std::cout << "Got queue: " << queue << std::endl;
 
 
-    BuildSwapChain();
+    if (headless)
+    {
+        BuildCaptureTarget();
+    }
+    else
+    {
+        BuildSwapChain();
+    }
 
     BuildDepthBuffer();
 
@@ -329,8 +346,11 @@ bool Application::Initialize()
     bindGroupDesc.entries = &bindGroupEntry;
     bindGroup = device.createBindGroup(bindGroupDesc);
 
-	glfwSetWindowUserPointer(window, this);
-	glfwSetFramebufferSizeCallback(window, StaticOnWindowResize);
+    if (!headless)
+    {
+        glfwSetWindowUserPointer(window, this);
+        glfwSetFramebufferSizeCallback(window, StaticOnWindowResize);
+    }
 
     return true;
 }
@@ -341,9 +361,17 @@ bool Application::Shutdown()
     // indexBuffer.destroy();
     uniformBuffer.destroy();
 
-    glfwDestroyWindow(window);
+    if (captureTexture != nullptr)
+    {
+        captureTexture.destroy();
+    }
+
+    if (window != nullptr)
+    {
+        glfwDestroyWindow(window);
 
-    glfwTerminate();
+        glfwTerminate();
+    }
 
     return true;
 }
@@ -365,28 +393,16 @@ void Application::OnFrame()
         return;
     }
 
-    // Model matrix
-    float angle1 = 2.0f * myUniforms.time;
-    glm::mat4x4 S = glm::scale(glm::mat4x4(1.0), glm::vec3(0.3f));
-    glm::mat4x4 T1 = glm::translate(glm::mat4x4(1.0), glm::vec3(0.5, 0.0, 0.0));
-
-    // View matrix
-    float angle2 = 3.0f * 3.14159f / 4.0f;
-    glm::vec3 focalPoint(0.0, 0.0, -2.0);
-    glm::mat4x4 R2 = glm::rotate(glm::mat4x4(1.0), -angle2, glm::vec3(1.0, 0.0, 0.0));
-    glm::mat4x4 T2 = glm::translate(glm::mat4x4(1.0), -focalPoint);
-    myUniforms.viewFromWorld = T2 * R2;
-
-    // Projection matrix
-    float ratio = float(windowWidth) / float(windowHeight);
-    float near = 0.01f;
-    float far = 100.0f;
-    float focalLength = 2.0f;
-    float fov = 2 * glm::atan(1 / focalLength);
-    myUniforms.clipFromView = glm::perspective(fov, ratio, near, far);
-
-    auto R1 = glm::rotate(glm::mat4x4(1.0), angle1, glm::vec3(0.0, 0.0, 1.0));
-    myUniforms.worldFromObject = R1 * T1 * S;
+    RenderFrame(nextTexture);
+
+    swapChain.present();
+
+    myUniforms.time += .01f;
+}
+
+void Application::RenderFrame(wgpu::TextureView target)
+{
+    updateUniforms(myUniforms, windowWidth, windowHeight);
     queue.writeBuffer(uniformBuffer, offsetof(MyUniforms, worldFromObject), &myUniforms.worldFromObject, sizeof(MyUniforms::worldFromObject));
 
     queue.writeBuffer(uniformBuffer, 0, &myUniforms, sizeof(MyUniforms));
@@ -398,7 +414,7 @@ void Application::OnFrame()
     wgpu::RenderPassDescriptor renderPassDesc{};
 
     wgpu::RenderPassColorAttachment renderPassColorAttachment{};
-    renderPassColorAttachment.view = nextTexture;
+    renderPassColorAttachment.view = target;
     renderPassColorAttachment.resolveTarget = nullptr;
     renderPassColorAttachment.loadOp = WGPULoadOp_Clear;
     renderPassColorAttachment.storeOp = WGPUStoreOp_Store;
@@ -438,10 +454,103 @@ void Application::OnFrame()
     cmdBufferDescriptor.label = "Command buffer";
     wgpu::CommandBuffer command = commandEncoder.finish(cmdBufferDescriptor);
     queue.submit(1, &command);
+}
 
-    swapChain.present();
+bool Application::CaptureFrame(std::filesystem::path const & path)
+{
+    RenderFrame(captureTextureView);
 
-    myUniforms.time += .01f;
+    // Rows of a texture to buffer copy must be 256 bytes aligned
+    uint32_t bytesPerRow = Align(windowWidth * 4, 256);
+
+    wgpu::BufferDescriptor readbackBufferDesc{};
+    readbackBufferDesc.size = uint64_t(bytesPerRow) * windowHeight;
+    readbackBufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::MapRead;
+    readbackBufferDesc.mappedAtCreation = false;
+    if (readbackBufferDesc.size > 16 * 1024 * 1024)
+    {
+        std::cerr << "Capture size exceeds the maxBufferSize limit" << std::endl;
+        return false;
+    }
+    wgpu::Buffer readbackBuffer = device.createBuffer(readbackBufferDesc);
+
+    wgpu::CommandEncoderDescriptor commandEncoderDesc{};
+    commandEncoderDesc.label = "Capture command encoder";
+    wgpu::CommandEncoder commandEncoder = device.createCommandEncoder(commandEncoderDesc);
+
+    wgpu::ImageCopyTexture source{};
+    source.texture = captureTexture;
+    source.mipLevel = 0;
+    source.origin = { 0, 0, 0 };
+    source.aspect = wgpu::TextureAspect::All;
+
+    wgpu::ImageCopyBuffer destination{};
+    destination.buffer = readbackBuffer;
+    destination.layout.offset = 0;
+    destination.layout.bytesPerRow = bytesPerRow;
+    destination.layout.rowsPerImage = windowHeight;
+
+    wgpu::Extent3D copySize = { windowWidth, windowHeight, 1 };
+    commandEncoder.copyTextureToBuffer(source, destination, copySize);
+
+    wgpu::CommandBufferDescriptor cmdBufferDescriptor = {};
+    cmdBufferDescriptor.label = "Capture command buffer";
+    wgpu::CommandBuffer command = commandEncoder.finish(cmdBufferDescriptor);
+    queue.submit(1, &command);
+
+    struct MapStatus
+    {
+        bool done = false;
+        bool success = false;
+    } mapStatus;
+    auto onBufferMapped = [](WGPUBufferMapAsyncStatus status, void * pUserData)
+    {
+        auto mapStatus = reinterpret_cast<MapStatus *>(pUserData);
+        mapStatus->done = true;
+        mapStatus->success = status == WGPUBufferMapAsyncStatus_Success;
+    };
+    wgpuBufferMapAsync(readbackBuffer, WGPUMapMode_Read, 0, readbackBufferDesc.size, onBufferMapped, &mapStatus);
+    while (!mapStatus.done)
+    {
+        wgpuDevicePoll(device, true, nullptr);
+    }
+    if (!mapStatus.success)
+    {
+        std::cerr << "Could not map the capture readback buffer" << std::endl;
+        readbackBuffer.destroy();
+        return false;
+    }
+
+    auto pixels = reinterpret_cast<uint8_t const *>(wgpuBufferGetConstMappedRange(readbackBuffer, 0, readbackBufferDesc.size));
+
+    // captureTexture is RGBA8, PPM only keeps RGB
+    std::ofstream file(path, std::ios::binary);
+    if (file.is_open())
+    {
+        file << "P6\n" << windowWidth << " " << windowHeight << "\n255\n";
+        std::vector<char> row(size_t(windowWidth) * 3);
+        for (uint32_t y = 0; y < windowHeight; ++y)
+        {
+            uint8_t const * pixelRow = pixels + size_t(y) * bytesPerRow;
+            for (uint32_t x = 0; x < windowWidth; ++x)
+            {
+                row[3 * x + 0] = char(pixelRow[4 * x + 0]);
+                row[3 * x + 1] = char(pixelRow[4 * x + 1]);
+                row[3 * x + 2] = char(pixelRow[4 * x + 2]);
+            }
+            file.write(row.data(), row.size());
+        }
+    }
+
+    readbackBuffer.unmap();
+    readbackBuffer.destroy();
+
+    if (!file)
+    {
+        std::cerr << "Could not write " << path << std::endl;
+        return false;
+    }
+    return true;
 }
 
 void Application::OnWindowResize(int width, int height)
@@ -497,15 +606,71 @@ void Application::BuildDepthBuffer()
     depthTextureView = depthTexture.createView(depthTextureViewDesc);
 }
 
+void Application::BuildCaptureTarget()
+{
+    // An sRGB format, like the surface's preferred one, so that captures
+    // match what is displayed
+    swapChainFormat = wgpu::TextureFormat::RGBA8UnormSrgb;
+
+    wgpu::TextureDescriptor captureTextureDesc;
+    captureTextureDesc.dimension = wgpu::TextureDimension::_2D;
+    captureTextureDesc.format = swapChainFormat;
+    captureTextureDesc.mipLevelCount = 1;
+    captureTextureDesc.sampleCount = 1;
+    captureTextureDesc.size = { windowWidth, windowHeight, 1 };
+    captureTextureDesc.usage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::CopySrc;
+    captureTextureDesc.viewFormatCount = 1;
+    captureTextureDesc.viewFormats = (WGPUTextureFormat*)&swapChainFormat;
+    captureTexture = device.createTexture(captureTextureDesc);
+
+    wgpu::TextureViewDescriptor captureTextureViewDesc;
+    captureTextureViewDesc.aspect = wgpu::TextureAspect::All;
+    captureTextureViewDesc.baseArrayLayer = 0;
+    captureTextureViewDesc.arrayLayerCount = 1;
+    captureTextureViewDesc.baseMipLevel = 0;
+    captureTextureViewDesc.mipLevelCount = 1;
+    captureTextureViewDesc.dimension = wgpu::TextureViewDimension::_2D;
+    captureTextureViewDesc.format = swapChainFormat;
+    captureTextureView = captureTexture.createView(captureTextureViewDesc);
+}
+
+// Without arguments, opens a window and renders continuously. With
+//   App --capture image.ppm [--width w] [--height h] [--time t]
+// renders a single frame without a window and writes it to image.ppm, e.g.
+// to produce reference images for SoftwareRender --compare.
 int main(int argc, char ** argv)
 {
     Application app;
 
+    std::filesystem::path capturePath;
+    float captureTime = 0.0f;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--capture") == 0) capturePath = argv[i + 1];
+        else if (std::strcmp(argv[i], "--width") == 0) app.windowWidth = uint32_t(std::atoi(argv[i + 1]));
+        else if (std::strcmp(argv[i], "--height") == 0) app.windowHeight = uint32_t(std::atoi(argv[i + 1]));
+        else if (std::strcmp(argv[i], "--time") == 0) captureTime = float(std::atof(argv[i + 1]));
+        else
+        {
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+            return -1;
+        }
+    }
+    app.headless = !capturePath.empty();
+
     if (!app.Initialize())
     {
         return -1;
     }
 
+    if (app.headless)
+    {
+        app.myUniforms.time = captureTime;
+        bool success = app.CaptureFrame(capturePath);
+        app.Shutdown();
+        return success ? 0 : -1;
+    }
+
     while (app.ShouldRun())
     {
         app.OnFrame();